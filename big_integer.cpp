@@ -4,6 +4,7 @@
 #include <ostream>
 #include <stdexcept>
 #include <algorithm>
+#include <random>
 
 big_integer::big_integer(long long a)
     : is_positive(a >= 0)
@@ -65,6 +66,78 @@ void big_integer::swap(big_integer& other) {
     std::swap(is_positive, other.is_positive);
 }
 
+size_t big_integer::bit_length() const {
+    if (is_zero()) {
+        return 0;
+    }
+    return number.size() * big_integer::base_cnt_bits - __builtin_clz(number.back());
+}
+
+bool big_integer::test_bit(size_t i) const {
+    size_t place = i / big_integer::base_cnt_bits;
+    if (place >= number.size()) {
+        return false;
+    }
+    return (number[place] >> (i % big_integer::base_cnt_bits)) & 1;
+}
+
+big_integer& big_integer::set_bit(size_t i) {
+    if (is_zero()) {
+        is_positive = true;
+    }
+    size_t place = i / big_integer::base_cnt_bits;
+    if (place >= number.size()) {
+        number.resize(place + 1, 0);
+    }
+    number[place] |= static_cast<uint32_t>(1) << (i % big_integer::base_cnt_bits);
+    return *this;
+}
+
+big_integer& big_integer::clear_bit(size_t i) {
+    size_t place = i / big_integer::base_cnt_bits;
+    if (place >= number.size()) {
+        return *this;
+    }
+    number[place] &= ~(static_cast<uint32_t>(1) << (i % big_integer::base_cnt_bits));
+    trim();
+    if (is_zero()) {
+        is_positive = true;
+    }
+    return *this;
+}
+
+size_t big_integer::countr_zero() const {
+    for (size_t i = 0; i < number.size(); ++i) {
+        if (number[i] != 0) {
+            return i * big_integer::base_cnt_bits + __builtin_ctz(number[i]);
+        }
+    }
+    return number.size() * big_integer::base_cnt_bits;
+}
+
+size_t big_integer::popcount() const {
+    size_t result = 0;
+    for (uint32_t place : number) {
+        result += __builtin_popcount(place);
+    }
+    return result;
+}
+
+size_t big_integer::limb_count() const {
+    return number.size();
+}
+
+bool big_integer::is_zero() const {
+    return number.size() == 1 && number[0] == 0;
+}
+
+int big_integer::sign() const {
+    if (is_zero()) {
+        return 0;
+    }
+    return is_positive ? 1 : -1;
+}
+
 void big_integer::trim() {
     while (number.size() > 1 && number.back() == 0) {
         number.pop_back();
@@ -189,6 +262,14 @@ big_integer::division_result big_integer::short_division(big_integer const& divi
     return {quotient, remainder};
 }
 
+uint32_t big_integer::short_remainder(uint32_t divisor) const {
+    uint64_t carry = 0;
+    for (size_t i = number.size(); i > 0; --i) {
+        carry = (carry * big_integer::base + static_cast<uint64_t>(number[i - 1])) % divisor;
+    }
+    return carry;
+}
+
 big_integer::division_result big_integer::division(big_integer const& dividend, big_integer const& divisor) {
     if (divisor.number.size() == 1) {
         return short_division(dividend, divisor.number[0], divisor.is_positive);
@@ -199,12 +280,7 @@ big_integer::division_result big_integer::division(big_integer const& dividend,
     if (dividend_copy < divisor_copy) {
         return {0, dividend};
     }
-    uint32_t k = 0;
-    uint32_t significant_place = divisor.number.back();
-    while (significant_place <= (big_integer::all_bits_one >> 1)) { //at most 32 iterations
-        significant_place <<= 1;
-        ++k;
-    }
+    uint32_t k = __builtin_clz(divisor.number.back()); // divisor is trimmed, so the top place is non-zero
     dividend_copy <<= k;
     divisor_copy <<= k;
     uint32_t n = dividend_copy.number.size();
@@ -564,3 +640,360 @@ std::string to_string(big_integer const& a) {
 std::ostream& operator<<(std::ostream& s, big_integer const& a) {
     return s << to_string(a);
 }
+
+
+namespace {
+    constexpr const uint32_t small_primes[] = {
+        2, 3, 5, 7, 11, 13, 17, 19, 23, 29, 31, 37, 41, 43, 47, 53,
+        59, 61, 67, 71, 73, 79, 83, 89, 97, 101, 103, 107, 109, 113, 127, 131,
+        137, 139, 149, 151, 157, 163, 167, 173, 179, 181, 191, 193, 197, 199, 211, 223,
+        227, 229, 233, 239, 241, 251, 257, 263, 269, 271, 277, 281, 283, 293, 307, 311,
+        313, 317, 331, 337, 347, 349, 353, 359, 367, 373, 379, 383, 389, 397, 401, 409,
+        419, 421, 431, 433, 439, 443, 449, 457, 461, 463, 467, 479, 487, 491, 499, 503,
+        509, 521, 523, 541, 547, 557, 563, 569, 571, 577, 587, 593, 599, 601, 607, 613,
+        617, 619, 631, 641, 643, 647, 653, 659, 661, 673, 677, 683, 691, 701, 709, 719,
+        727, 733, 739, 743, 751, 757, 761, 769, 773, 787, 797, 809, 811, 821, 823, 827,
+        829, 839, 853, 857, 859, 863, 877, 881, 883, 887, 907, 911, 919, 929, 937, 941,
+        947, 953, 967, 971, 977, 983, 991, 997
+    };
+    // every composite below this has a factor in small_primes
+    constexpr const uint32_t trial_division_bound = 1009 * 1009;
+
+    // m should be odd
+    int jacobi_symbol(uint32_t a, uint32_t m) {
+        int result = 1;
+        a %= m;
+        while (a != 0) {
+            while (a % 2 == 0) {
+                a /= 2;
+                if (m % 8 == 3 || m % 8 == 5) {
+                    result = -result;
+                }
+            }
+            std::swap(a, m);
+            if (a % 4 == 3 && m % 4 == 3) {
+                result = -result;
+            }
+            a %= m;
+        }
+        return m == 1 ? result : 0;
+    }
+
+    bool is_square(big_integer const& x) {
+        big_integer root = big_integer(1) << static_cast<int>((x.bit_length() + 1) / 2);
+        while (true) { // Newton's method, decreasing from above
+            big_integer next = (root + x / root) >> 1;
+            if (next >= root) {
+                break;
+            }
+            root = next;
+        }
+        return root * root == x;
+    }
+}
+
+// arithmetic modulo an odd number in the Montgomery form with R = base^(number of places)
+struct big_integer::montgomery_context {
+    explicit montgomery_context(big_integer const& m);
+
+    bool strong_probable_prime(big_integer const& witness);
+    bool strong_lucas_probable_prime();
+
+private:
+    using residue = std::vector<uint32_t>;
+
+    big_integer modulus;
+    size_t cnt_places;
+    uint32_t inverse; // -modulus^(-1) modulo base
+    residue r_squared;
+    residue one;
+    residue minus_one;
+    residue scratch;
+    big_integer miller_rabin_exponent; // odd part of modulus - 1
+    size_t miller_rabin_cnt_twos;
+    big_integer lucas_index; // odd part of modulus + 1
+    size_t lucas_cnt_twos;
+
+    residue to_form(big_integer const& a); // a should be in [0, modulus)
+    residue power(residue const& a, big_integer const& exponent);
+    void multiply(residue& result, residue const& a, residue const& b);
+    void add(residue& result, residue const& a, residue const& b);
+    void subtract(residue& result, residue const& a, residue const& b);
+    void halve(residue& a);
+    bool less_than_modulus(residue const& a) const;
+    uint32_t subtract_modulus(residue& a) const;
+    static bool is_zero(residue const& a);
+};
+
+big_integer::montgomery_context::montgomery_context(big_integer const& m)
+    : modulus(m),
+      cnt_places(m.number.size()),
+      inverse(1),
+      scratch(cnt_places + 2),
+      miller_rabin_exponent(m - 1),
+      miller_rabin_cnt_twos(miller_rabin_exponent.countr_zero()),
+      lucas_index(m + 1),
+      lucas_cnt_twos(lucas_index.countr_zero())
+{
+    miller_rabin_exponent >>= static_cast<int>(miller_rabin_cnt_twos);
+    lucas_index >>= static_cast<int>(lucas_cnt_twos);
+    for (size_t i = 0; i < 5; ++i) { // Newton's iteration doubles the number of correct bits
+        inverse *= 2 - modulus.number[0] * inverse;
+    }
+    inverse = -inverse;
+    r_squared = ((big_integer(1) << static_cast<int>(2 * big_integer::base_cnt_bits * cnt_places)) % modulus).number;
+    r_squared.resize(cnt_places, 0);
+    one = to_form(1);
+    minus_one = residue(cnt_places, 0);
+    subtract(minus_one, minus_one, one);
+}
+
+big_integer::montgomery_context::residue big_integer::montgomery_context::to_form(big_integer const& a) {
+    residue result = a.number;
+    result.resize(cnt_places, 0);
+    multiply(result, result, r_squared);
+    return result;
+}
+
+big_integer::montgomery_context::residue big_integer::montgomery_context::power(residue const& a,
+                                                                                big_integer const& exponent) {
+    residue result = one;
+    for (size_t i = exponent.bit_length(); i > 0; --i) {
+        multiply(result, result, result);
+        if (exponent.test_bit(i - 1)) {
+            multiply(result, result, a);
+        }
+    }
+    return result;
+}
+
+void big_integer::montgomery_context::multiply(residue& result, residue const& a, residue const& b) {
+    std::fill(scratch.begin(), scratch.end(), 0);
+    for (size_t i = 0; i < cnt_places; ++i) {
+        uint64_t carry = 0, cur_num_place = 0;
+        for (size_t j = 0; j < cnt_places; ++j) {
+            cur_num_place = static_cast<uint64_t>(scratch[j])
+                            + static_cast<uint64_t>(a[j]) * static_cast<uint64_t>(b[i])
+                            + carry;
+            scratch[j] = cur_num_place & big_integer::all_bits_one;
+            carry = cur_num_place >> big_integer::base_cnt_bits;
+        }
+        cur_num_place = static_cast<uint64_t>(scratch[cnt_places]) + carry;
+        scratch[cnt_places] = cur_num_place & big_integer::all_bits_one;
+        scratch[cnt_places + 1] = cur_num_place >> big_integer::base_cnt_bits;
+
+        uint64_t m = static_cast<uint32_t>(scratch[0] * inverse);
+        carry = (static_cast<uint64_t>(scratch[0]) + m * modulus.number[0]) >> big_integer::base_cnt_bits;
+        for (size_t j = 1; j < cnt_places; ++j) {
+            cur_num_place = static_cast<uint64_t>(scratch[j])
+                            + m * static_cast<uint64_t>(modulus.number[j])
+                            + carry;
+            scratch[j - 1] = cur_num_place & big_integer::all_bits_one;
+            carry = cur_num_place >> big_integer::base_cnt_bits;
+        }
+        cur_num_place = static_cast<uint64_t>(scratch[cnt_places]) + carry;
+        scratch[cnt_places - 1] = cur_num_place & big_integer::all_bits_one;
+        scratch[cnt_places] = scratch[cnt_places + 1] + (cur_num_place >> big_integer::base_cnt_bits);
+    }
+    result.assign(scratch.begin(), scratch.begin() + cnt_places);
+    if (scratch[cnt_places] != 0 || !less_than_modulus(result)) {
+        subtract_modulus(result);
+    }
+}
+
+void big_integer::montgomery_context::add(residue& result, residue const& a, residue const& b) {
+    uint64_t carry = 0;
+    result.resize(cnt_places);
+    for (size_t i = 0; i < cnt_places; ++i) {
+        uint64_t cur_num_place = static_cast<uint64_t>(a[i]) + static_cast<uint64_t>(b[i]) + carry;
+        result[i] = cur_num_place & big_integer::all_bits_one;
+        carry = cur_num_place >> big_integer::base_cnt_bits;
+    }
+    if (carry != 0 || !less_than_modulus(result)) {
+        subtract_modulus(result);
+    }
+}
+
+void big_integer::montgomery_context::subtract(residue& result, residue const& a, residue const& b) {
+    int64_t carry = 0;
+    result.resize(cnt_places);
+    for (size_t i = 0; i < cnt_places; ++i) {
+        int64_t cur_num_place = static_cast<int64_t>(a[i]) - static_cast<int64_t>(b[i]) - carry;
+        if (cur_num_place < 0) {
+            cur_num_place += big_integer::base;
+            carry = 1;
+        } else {
+            carry = 0;
+        }
+        result[i] = cur_num_place;
+    }
+    if (carry != 0) {
+        uint64_t add_carry = 0;
+        for (size_t i = 0; i < cnt_places; ++i) {
+            uint64_t cur_num_place = static_cast<uint64_t>(result[i])
+                                     + static_cast<uint64_t>(modulus.number[i])
+                                     + add_carry;
+            result[i] = cur_num_place & big_integer::all_bits_one;
+            add_carry = cur_num_place >> big_integer::base_cnt_bits;
+        }
+    }
+}
+
+void big_integer::montgomery_context::halve(residue& a) {
+    uint32_t carry = 0;
+    if (a[0] & 1) { // modulus is odd, so a + modulus is even
+        for (size_t i = 0; i < cnt_places; ++i) {
+            uint64_t cur_num_place = static_cast<uint64_t>(a[i])
+                                     + static_cast<uint64_t>(modulus.number[i])
+                                     + carry;
+            a[i] = cur_num_place & big_integer::all_bits_one;
+            carry = cur_num_place >> big_integer::base_cnt_bits;
+        }
+    }
+    for (size_t i = cnt_places; i > 0; --i) {
+        uint32_t temp_carry = a[i - 1] & 1;
+        a[i - 1] = (a[i - 1] >> 1) | (carry << (big_integer::base_cnt_bits - 1));
+        carry = temp_carry;
+    }
+}
+
+bool big_integer::montgomery_context::less_than_modulus(residue const& a) const {
+    for (size_t i = cnt_places; i > 0; --i) {
+        if (a[i - 1] != modulus.number[i - 1]) {
+            return a[i - 1] < modulus.number[i - 1];
+        }
+    }
+    return false;
+}
+
+uint32_t big_integer::montgomery_context::subtract_modulus(residue& a) const {
+    int64_t carry = 0;
+    for (size_t i = 0; i < cnt_places; ++i) {
+        int64_t cur_num_place = static_cast<int64_t>(a[i]) - static_cast<int64_t>(modulus.number[i]) - carry;
+        if (cur_num_place < 0) {
+            cur_num_place += big_integer::base;
+            carry = 1;
+        } else {
+            carry = 0;
+        }
+        a[i] = cur_num_place;
+    }
+    return carry;
+}
+
+bool big_integer::montgomery_context::is_zero(residue const& a) {
+    return std::all_of(a.begin(), a.end(), [](uint32_t place) {return place == 0;});
+}
+
+bool big_integer::montgomery_context::strong_probable_prime(big_integer const& witness) {
+    residue x = power(to_form(witness), miller_rabin_exponent);
+    if (x == one || x == minus_one) {
+        return true;
+    }
+    for (size_t r = 1; r < miller_rabin_cnt_twos; ++r) {
+        multiply(x, x, x);
+        if (x == minus_one) {
+            return true;
+        }
+        if (x == one) { // a non-trivial square root of one was found
+            return false;
+        }
+    }
+    return false;
+}
+
+// Selfridge's method A parameters: P = 1, Q = (1 - D) / 4
+bool big_integer::montgomery_context::strong_lucas_probable_prime() {
+    int64_t d = 5;
+    for (size_t attempt = 0;; ++attempt, d = (d > 0) ? -(d + 2) : -d + 2) {
+        uint32_t abs_d = static_cast<uint32_t>(std::abs(d));
+        int jacobi = jacobi_symbol(modulus.short_remainder(abs_d), abs_d);
+        if (abs_d % 4 == 3 && modulus.number[0] % 4 == 3) {
+            jacobi = -jacobi;
+        }
+        if (d < 0 && modulus.number[0] % 4 == 3) {
+            jacobi = -jacobi;
+        }
+        if (jacobi == -1) {
+            break;
+        }
+        if (jacobi == 0 && modulus != abs_d) {
+            return false;
+        }
+        if (attempt == 10 && is_square(modulus)) { // otherwise there is no suitable D
+            return false;
+        }
+    }
+    int64_t q = (1 - d) / 4;
+    residue d_form = to_form(d < 0 ? modulus + d : big_integer(d));
+    residue q_form = to_form(q < 0 ? modulus + q : big_integer(q));
+
+    residue u = one, v = one, q_power = q_form, temp;
+    for (size_t i = lucas_index.bit_length() - 1; i > 0; --i) {
+        multiply(u, u, v);
+        multiply(v, v, v);
+        subtract(v, v, q_power);
+        subtract(v, v, q_power);
+        multiply(q_power, q_power, q_power);
+        if (lucas_index.test_bit(i - 1)) {
+            add(temp, u, v);
+            halve(temp);
+            multiply(u, d_form, u);
+            add(v, u, v);
+            halve(v);
+            u.swap(temp);
+            multiply(q_power, q_power, q_form);
+        }
+    }
+    if (is_zero(u) || is_zero(v)) {
+        return true;
+    }
+    for (size_t r = 1; r < lucas_cnt_twos; ++r) {
+        multiply(v, v, v);
+        subtract(v, v, q_power);
+        subtract(v, v, q_power);
+        if (is_zero(v)) {
+            return true;
+        }
+        multiply(q_power, q_power, q_power);
+    }
+    return false;
+}
+
+bool big_integer::probable_prime(big_integer const& x, size_t rounds,
+                                 std::function<big_integer(big_integer const&)> const& random_below_bound) {
+    if (x < 2) {
+        return false;
+    }
+    for (uint32_t p : small_primes) {
+        if (x.limb_count() == 1 && x.number[0] == p) {
+            return true;
+        }
+        if (x.short_remainder(p) == 0) {
+            return false;
+        }
+    }
+    if (x < trial_division_bound) {
+        return true;
+    }
+    montgomery_context context(x);
+    if (!context.strong_probable_prime(2) || !context.strong_lucas_probable_prime()) {
+        return false;
+    }
+    big_integer witness_bound = x - 3;
+    for (size_t i = 0; i < rounds; ++i) {
+        if (!context.strong_probable_prime(random_below_bound(witness_bound) + 2)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool is_probable_prime(big_integer const& x, size_t rounds) {
+    static thread_local std::mt19937_64 generator = [] {
+        std::random_device device;
+        std::seed_seq seed{device(), device(), device(), device(), device(), device(), device(), device()};
+        return std::mt19937_64(seed);
+    }();
+    return is_probable_prime(x, rounds, generator);
+}
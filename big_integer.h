@@ -1,6 +1,11 @@
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
+#include <functional>
 #include <iosfwd>
+#include <random>
+#include <stdexcept>
 #include <string>
 #include <vector>
 
@@ -27,6 +32,17 @@ struct big_integer
 
     void swap(big_integer& other);
 
+    // bit queries look at the absolute value, not at the two's complement form
+    size_t bit_length() const;
+    bool test_bit(size_t i) const;
+    big_integer& set_bit(size_t i);
+    big_integer& clear_bit(size_t i);
+    size_t countr_zero() const; // base_cnt_bits for zero, like std::countr_zero
+    size_t popcount() const;
+    size_t limb_count() const;
+    bool is_zero() const;
+    int sign() const;
+
     big_integer& operator=(big_integer const& other) = default;
 
     big_integer& operator+=(big_integer const& rhs);
@@ -61,6 +77,13 @@ struct big_integer
 
     friend std::string to_string(big_integer const& a);
 
+    template <typename URBG>
+    friend big_integer random_bits(size_t n, URBG& generator);
+    template <typename URBG>
+    friend big_integer random_below(big_integer const& bound, URBG& generator);
+    template <typename URBG>
+    friend bool is_probable_prime(big_integer const& x, size_t rounds, URBG& generator);
+
 private:
     std::vector<uint32_t> number;
     bool is_positive;
@@ -71,6 +94,11 @@ private:
     struct division_result;
     static division_result division(big_integer const&, big_integer const&);
     static division_result short_division(big_integer const&, uint32_t const, bool const);
+    uint32_t short_remainder(uint32_t divisor) const;
+
+    struct montgomery_context;
+    static bool probable_prime(big_integer const& x, size_t rounds,
+                               std::function<big_integer(big_integer const&)> const& random_below_bound);
 
     void inverse();
 
@@ -108,3 +136,47 @@ bool operator>=(big_integer const& a, big_integer const& b);
 
 std::string to_string(big_integer const& a);
 std::ostream& operator<<(std::ostream& s, big_integer const& a);
+
+// uniformly distributed in [0, 2^n)
+template <typename URBG>
+big_integer random_bits(size_t n, URBG& generator) {
+    big_integer result;
+    if (n == 0) {
+        return result;
+    }
+    std::uniform_int_distribution<uint32_t> distribution(0, big_integer::all_bits_one);
+    result.number.resize((n + big_integer::base_cnt_bits - 1) / big_integer::base_cnt_bits);
+    for (uint32_t& place : result.number) {
+        place = distribution(generator);
+    }
+    if (n % big_integer::base_cnt_bits != 0) {
+        result.number.back() &= big_integer::all_bits_one >> (big_integer::base_cnt_bits - n % big_integer::base_cnt_bits);
+    }
+    result.trim();
+    return result;
+}
+
+// uniformly distributed in [0, bound)
+template <typename URBG>
+big_integer random_below(big_integer const& bound, URBG& generator) {
+    if (bound.sign() <= 0) {
+        throw std::invalid_argument("non-positive bound given to random_below");
+    }
+    size_t cnt_bits = bound.bit_length();
+    big_integer result = random_bits(cnt_bits, generator);
+    while (result >= bound) { // less than 2 iterations on average
+        result = random_bits(cnt_bits, generator);
+    }
+    return result;
+}
+
+// BPSW (base 2 Miller-Rabin and strong Lucas) followed by rounds of Miller-Rabin with bases taken from generator
+template <typename URBG>
+bool is_probable_prime(big_integer const& x, size_t rounds, URBG& generator) {
+    return big_integer::probable_prime(x, rounds, [&generator](big_integer const& bound) {
+        return random_below(bound, generator);
+    });
+}
+
+// same, with bases from a per-thread std::mt19937_64 seeded from std::random_device, so not reproducible
+bool is_probable_prime(big_integer const& x, size_t rounds);
@@ -0,0 +1,234 @@
+#include <gtest/gtest.h>
+
+#include <limits>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "big_integer.h"
+
+TEST(bit_queries, zero) {
+    big_integer a;
+    EXPECT_TRUE(a.is_zero());
+    EXPECT_EQ(a.sign(), 0);
+    EXPECT_EQ(a.bit_length(), 0u);
+    EXPECT_EQ(a.popcount(), 0u);
+    EXPECT_EQ(a.countr_zero(), big_integer::base_cnt_bits);
+    EXPECT_EQ(a.limb_count(), 1u);
+    EXPECT_FALSE(a.test_bit(0));
+    EXPECT_FALSE(a.test_bit(1000));
+}
+
+TEST(bit_queries, single_limb) {
+    big_integer a(0b101100);
+    EXPECT_FALSE(a.is_zero());
+    EXPECT_EQ(a.sign(), 1);
+    EXPECT_EQ(a.bit_length(), 6u);
+    EXPECT_EQ(a.popcount(), 3u);
+    EXPECT_EQ(a.countr_zero(), 2u);
+    EXPECT_TRUE(a.test_bit(2));
+    EXPECT_FALSE(a.test_bit(4));
+    EXPECT_TRUE(a.test_bit(5));
+    EXPECT_FALSE(a.test_bit(6));
+}
+
+TEST(bit_queries, multi_limb) {
+    big_integer a = (big_integer(1) << 100) + (big_integer(1) << 64);
+    EXPECT_EQ(a.limb_count(), 4u);
+    EXPECT_EQ(a.bit_length(), 101u);
+    EXPECT_EQ(a.popcount(), 2u);
+    EXPECT_EQ(a.countr_zero(), 64u);
+    EXPECT_TRUE(a.test_bit(64));
+    EXPECT_TRUE(a.test_bit(100));
+    EXPECT_FALSE(a.test_bit(99));
+
+    big_integer b("123456789012345678901234567890");
+    EXPECT_EQ(b.bit_length(), 97u);
+}
+
+TEST(bit_queries, negative_uses_absolute_value) {
+    big_integer a(-12);
+    EXPECT_EQ(a.sign(), -1);
+    EXPECT_EQ(a.bit_length(), 4u);
+    EXPECT_EQ(a.popcount(), 2u);
+    EXPECT_EQ(a.countr_zero(), 2u);
+    EXPECT_TRUE(a.test_bit(3));
+    EXPECT_FALSE(a.test_bit(0));
+
+    big_integer b(std::numeric_limits<long long>::min());
+    EXPECT_EQ(b.bit_length(), 64u);
+    EXPECT_EQ(b.popcount(), 1u);
+    EXPECT_EQ(b.countr_zero(), 63u);
+}
+
+TEST(bit_queries, set_and_clear_bit) {
+    big_integer a;
+    a.set_bit(100);
+    EXPECT_EQ(a, big_integer(1) << 100);
+    a.set_bit(0);
+    EXPECT_EQ(a, (big_integer(1) << 100) + 1);
+    a.clear_bit(100);
+    EXPECT_EQ(a, 1);
+    EXPECT_EQ(a.limb_count(), 1u);
+    a.clear_bit(1000);
+    EXPECT_EQ(a, 1);
+    a.clear_bit(0);
+    EXPECT_TRUE(a.is_zero());
+
+    big_integer b(-5);
+    b.set_bit(1);
+    EXPECT_EQ(b, -7);
+    b.clear_bit(0);
+    EXPECT_EQ(b, -6);
+    b.clear_bit(1);
+    b.clear_bit(2);
+    EXPECT_EQ(b.sign(), 0);
+    b.set_bit(3);
+    EXPECT_EQ(b, 8);
+}
+
+TEST(bit_queries, set_bit_on_negative_zero) {
+    big_integer a = big_integer(0) * big_integer(-5);
+    EXPECT_EQ(a.sign(), 0);
+    a.set_bit(3);
+    EXPECT_EQ(a, 8);
+
+    big_integer b = big_integer(-14) % big_integer(7);
+    EXPECT_EQ(b.sign(), 0);
+    b.set_bit(0);
+    EXPECT_EQ(b, 1);
+}
+
+TEST(division, normalization) {
+    // top places of the divisor with every possible count of leading zeros
+    for (size_t shift = 0; shift < big_integer::base_cnt_bits; ++shift) {
+        big_integer divisor = (big_integer(1) << static_cast<int>(64 + shift)) + 12345;
+        big_integer dividend = big_integer("987654321987654321987654321987654321987654321") + shift;
+        big_integer quotient = dividend / divisor;
+        big_integer remainder = dividend % divisor;
+        EXPECT_EQ(quotient * divisor + remainder, dividend);
+        EXPECT_TRUE(remainder >= 0 && remainder < divisor);
+    }
+}
+
+TEST(division, random) {
+    std::mt19937 generator(448);
+    std::uniform_int_distribution<uint32_t> place(0, big_integer::all_bits_one);
+    std::uniform_int_distribution<int> cnt_places(2, 8);
+    for (size_t i = 0; i < 2000; ++i) {
+        big_integer a, b;
+        for (int j = cnt_places(generator); j > 0; --j) {
+            a = (a << big_integer::base_cnt_bits) + place(generator);
+        }
+        for (int j = cnt_places(generator); j > 0; --j) {
+            b = (b << big_integer::base_cnt_bits) + place(generator);
+        }
+        if (b == 0) {
+            continue;
+        }
+        if (i % 2 == 1) {
+            a = -a;
+        }
+        big_integer q = a / b;
+        big_integer r = a % b;
+        EXPECT_EQ(q * b + r, a);
+    }
+}
+
+TEST(random, random_bits) {
+    std::mt19937 generator(448);
+    EXPECT_EQ(random_bits(0, generator), 0);
+    for (size_t n : {1u, 31u, 32u, 33u, 64u, 100u}) {
+        bool top_bit_seen = false;
+        for (size_t i = 0; i < 200; ++i) {
+            big_integer a = random_bits(n, generator);
+            EXPECT_GE(a, 0);
+            EXPECT_LE(a.bit_length(), n);
+            top_bit_seen |= a.bit_length() == n;
+        }
+        EXPECT_TRUE(top_bit_seen);
+    }
+}
+
+TEST(random, random_below) {
+    std::mt19937 generator(448);
+    big_integer bound("123456789123456789123456789");
+    for (size_t i = 0; i < 1000; ++i) {
+        big_integer a = random_below(bound, generator);
+        EXPECT_TRUE(a >= 0 && a < bound);
+    }
+    for (size_t i = 0; i < 100; ++i) {
+        EXPECT_EQ(random_below(1, generator), 0);
+    }
+    EXPECT_THROW(random_below(0, generator), std::invalid_argument);
+    EXPECT_THROW(random_below(-5, generator), std::invalid_argument);
+}
+
+TEST(primality, small_range) {
+    for (int i = -10; i < 100000; ++i) {
+        bool is_prime = i >= 2;
+        for (int j = 2; j * j <= i; ++j) {
+            if (i % j == 0) {
+                is_prime = false;
+                break;
+            }
+        }
+        EXPECT_EQ(is_probable_prime(i, 2), is_prime) << i;
+    }
+}
+
+TEST(primality, trial_division_boundary) {
+    EXPECT_TRUE(is_probable_prime(997, 0));
+    EXPECT_TRUE(is_probable_prime(1009, 0));
+    EXPECT_FALSE(is_probable_prime(1009 * 1009, 0));
+    EXPECT_TRUE(is_probable_prime(1018091, 0)); // smallest prime above 1009^2
+    EXPECT_FALSE(is_probable_prime(1013 * 1019, 0));
+}
+
+TEST(primality, above_trial_division_bound) {
+    // odd numbers here without a factor below 1009 reach the Montgomery BPSW path
+    const uint32_t from = 1009 * 1009, to = from + 200000;
+    std::vector<bool> is_composite(to, false);
+    for (uint32_t i = 2; i * i < to; ++i) {
+        if (!is_composite[i]) {
+            for (uint32_t j = i * i; j < to; j += i) {
+                is_composite[j] = true;
+            }
+        }
+    }
+    std::mt19937 generator(448);
+    for (uint32_t i = from; i < to; i += 2) {
+        EXPECT_EQ(is_probable_prime(i, 1, generator), !is_composite[i]) << i;
+    }
+}
+
+TEST(primality, strong_pseudoprimes) {
+    // no factor below 1009, so these are not rejected by trial division
+    // base 2 strong pseudoprimes, rejected by the strong Lucas test
+    EXPECT_FALSE(is_probable_prime(1678541, 0));
+    EXPECT_FALSE(is_probable_prime(2284453, 0));
+    EXPECT_FALSE(is_probable_prime(1093 * 1093, 0));
+    EXPECT_FALSE(is_probable_prime(big_integer("3825123056546413051"), 0));
+    // strong Lucas pseudoprimes, rejected by the base 2 round
+    EXPECT_FALSE(is_probable_prime(1711469, 0));
+    EXPECT_FALSE(is_probable_prime(2263127, 0));
+}
+
+TEST(primality, caller_generator) {
+    big_integer m127 = (big_integer(1) << 127) - 1;
+    std::mt19937 first(448), second(448);
+    EXPECT_TRUE(is_probable_prime(m127, 10, first));
+    EXPECT_TRUE(is_probable_prime(m127, 10, second));
+    EXPECT_EQ(first, second);
+    EXPECT_FALSE(is_probable_prime(m127 * m127, 10, first));
+}
+
+TEST(primality, mersenne) {
+    big_integer m127 = (big_integer(1) << 127) - 1;
+    big_integer m521 = (big_integer(1) << 521) - 1;
+    EXPECT_TRUE(is_probable_prime(m127, 5));
+    EXPECT_TRUE(is_probable_prime(m521, 5));
+    EXPECT_FALSE(is_probable_prime((big_integer(1) << 128) - 1, 5));
+    EXPECT_FALSE(is_probable_prime(m127 * m521, 5));
+    EXPECT_FALSE(is_probable_prime(m127 * m127, 5));
+}